@@ -20,13 +20,21 @@
 
 #define TURN 1
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <iostream>
 
+struct Move {
+  int fr, fc, sr, sc;
+  bool enpassant;
+  int promotion;  // Piece type the pawn becomes, NONE otherwise
+};
+
 class game {
 public:
-  game();
+  explicit game(std::ostream& out = std::cout);
   void readBoard(bool id);
   void makeMove(std::string a, std::string b);
   bool isMoveLegal(int fr, int fc, int sr, int sc, bool& isEnpassant);
@@ -34,30 +42,50 @@ public:
   void applyMove(int firstRow, int firstColumn, int secondRow, int secondColumn);
   void promote(std::string piece);
   void showMoves(std::string cell);
+
+  // Every move the side to move may play, promotions expanded per piece
+  std::vector<Move> generateMoves();
+  void playMove(const Move& move);
+  uint64_t hashKey() const;
+
+  // Pseudo-legal moves may leave the king en prise, so a move is illegal
+  // when the opponent can then capture the king
+  bool canCaptureKing();
+  bool inCheck();
+  bool loadFen(const std::string& fen);
+
   bool isWhite;
   bool isWhitesTurn;
 
 private:
-  std::vector<std::vector<int>> board;
+  // Fixed size so a game lives in one block and copies without allocating
+  std::array<std::array<int, 8>, 8> board;
   std::vector<std::pair<int, int>> moves;
 
   std::pair<int, int> selectedCell;
   bool cellSelected;
 
-  int whiteDirection;
-
   std::pair<int, int> pendingPromotionCell;
   bool pendingPromotion;
+
+  // Where the game prints its board and debug output
+  std::ostream* out;
+
   std::vector<std::pair<int, int>> getPossibleMoves(int fr, int fc, int cell);
-  void getRowColumn(std::string cell, int &row, int &column, bool isWhite);
+  void getRowColumn(std::string cell, int &row, int &column);
   char getPieceChar(int pieceType);
   int getPieceType(char pieceChar);
   void checkCheckmate();
+  bool followsRules(int fr, int fc, int sr, int sc, bool& isEnpassant);
+  bool isAttacked(int row, int column, int byColor) const;
+  void finishPromotion(int pieceType);
 };
 
 extern std::vector<int> pawnRow;
 extern std::vector<int> kingRow;
 extern std::vector<int> emptyRow;
 extern std::vector<std::pair<int, char>> pieceCharPairs;
+extern const std::array<std::array<uint64_t, 128>, 64> zobristKeys;
+extern const uint64_t zobristBlackToMove;
 
 #endif
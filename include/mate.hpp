@@ -0,0 +1,72 @@
+#ifndef MATE_HPP
+#define MATE_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "board.hpp"
+
+class PerftTable;
+
+// Longest mate that may be asked for, deeper searches never finish anyway
+constexpr int MAX_MATE_MOVES = 50;
+
+struct MateResult {
+  bool mate = false;
+  bool unknown = false;  // Node limit hit before a proof or disproof
+  bool cached = false;   // Answered from the cache file, not searched
+  Move firstMove{};
+  uint64_t nodes = 0;
+  double seconds = 0;
+};
+
+// Proof-number search for a forced mate in a fixed number of moves by the
+// side to move. The tree is stored as moves only, positions are replayed
+// from the root while descending.
+class MateSolver {
+public:
+  MateSolver(const game& root, int moves, size_t nodeLimit);
+  MateResult solve();
+
+private:
+  struct Node {
+    Move move;
+    uint64_t key;
+    uint32_t proof;
+    uint32_t disproof;
+    int32_t parent;
+    int32_t firstChild;
+    int32_t childCount;
+    bool expanded;
+  };
+
+  // Shallowest depth a position was proven at, deepest it was disproven at
+  struct Known {
+    int proven;
+    int disproven;
+  };
+
+  game root;
+  int plies;
+  size_t nodeLimit;
+  std::vector<Node> nodes;
+  std::unordered_map<uint64_t, Known> table;
+
+  void expand(int index, game& position, int depth, bool attacker);
+  void update(int index, bool attacker);
+  void remember(uint64_t key, int depth, bool proven);
+};
+
+// Solves every puzzle in an EPD file on several threads and reports each.
+// A "dm" opcode on a line overrides the number of moves. With a cache,
+// known puzzles are answered from it and new results are stored.
+void runMateFile(const std::string& path, int moves, int threads,
+                 std::ostream& out, PerftTable* cache = nullptr);
+
+void runMate(const game& position, int moves, std::ostream& out,
+             PerftTable* cache = nullptr);
+
+#endif
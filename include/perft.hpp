@@ -0,0 +1,69 @@
+#ifndef PERFT_HPP
+#define PERFT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "board.hpp"
+
+// Subtree counts shared between perft threads. Entries are written without
+// locks: the key is stored xor'ed with the rest, so a torn write simply
+// fails verification on the next probe. Deeper and newer entries win.
+// The mate solver keeps its results here too, under its own keys.
+class PerftTable {
+public:
+  explicit PerftTable(size_t megabytes);
+
+  // Backed by a memory-mapped file so counts survive between sessions.
+  // A new or empty file gets the given size, an existing cache keeps its
+  // own. Any other file is refused rather than overwritten.
+  PerftTable(const std::string& path, size_t megabytes);
+  ~PerftTable();
+  PerftTable(const PerftTable&) = delete;
+  PerftTable& operator=(const PerftTable&) = delete;
+
+  bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+  void store(uint64_t key, int depth, uint64_t nodes);
+  size_t size() const { return mask + 1; }
+
+private:
+  struct Entry {
+    std::atomic<uint64_t> check{0};  // key ^ nodes ^ info
+    std::atomic<uint64_t> nodes{0};
+    std::atomic<uint64_t> info{0};  // age << 8 | depth
+  };
+
+  struct FileHeader {
+    uint64_t magic;
+    uint64_t count;
+    uint64_t generation;
+  };
+
+  size_t slot(uint64_t key, int depth) const;
+
+  std::vector<Entry> storage;
+  void* mapping = nullptr;
+  size_t mappingSize = 0;
+  Entry* entries;
+  uint64_t mask;
+  uint32_t age = 0;  // Entries from older sessions may be replaced freely
+};
+
+// Leaf nodes at the given depth, table may be null
+uint64_t perft(game& position, int depth, PerftTable* table);
+
+// Splits the first two plies into tasks and counts them on several threads
+uint64_t parallelPerft(const game& position, int depth, int threads,
+                       PerftTable& table);
+
+// Reports a cached count straight away, otherwise runs the parallel count.
+// With compare the single-threaded count without a table runs first, to
+// report the speedup. The parallel run uses cache when given, a fresh
+// table otherwise.
+void runPerft(const game& position, int depth, int threads, bool compare,
+              std::ostream& out, PerftTable* cache = nullptr);
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ui.hpp"
+
+// Serves many games at once over a Unix domain socket. Every connection
+// gets its own session, driven by the same commands as the CLI.
+class GameServer {
+public:
+  GameServer(std::string socketPath, size_t maxSessions);
+  ~GameServer();
+  void run();
+
+private:
+  struct Session {
+    Session() : ui(output) {}
+
+    int fd = -1;
+    int nextFree = -1;
+    bool hungUp = false;  // Client closed its side, finish and close
+    std::string input;
+    std::string pending;
+    std::ostringstream output;
+    ChessUI ui;
+  };
+
+  std::string socketPath;
+  int listenFd;
+  int epollFd;
+  int spareFd = -1;  // Given up to turn clients away when out of fds
+  bool listening = true;
+
+  // Sessions are allocated once up front and recycled through a free list
+  std::vector<Session> sessions;
+  int freeSession;
+  std::vector<int> closedSessions;
+
+  void acceptClients();
+  void readClient(int id);
+  void runInput(int id);
+  bool flushClient(int id);
+  void closeClient(int id);
+  void watchClient(int id, bool wantWrite);
+  void watchListener(bool enabled);
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef UI_HPP
+#define UI_HPP
+
+#include <iostream>
+#include <string>
+
+#include "board.hpp"
+
+class PerftTable;
+
+class ChessUI {
+public:
+    explicit ChessUI(std::ostream& out = std::cout);
+
+    // Interactive loop on stdin
+    void run();
+
+    // Handle one line of input, used by run() and the game server
+    void handleLine(std::string input);
+    void printWelcome();
+    void printHelp();
+    void printPrompt();
+    void reset();
+    void setCache(PerftTable* table) { cache = table; }
+
+    // perft and mate can run for hours, the game server turns them off
+    void setAnalysis(bool enabled) { analysis = enabled; }
+    bool isRunning() const { return running; }
+
+private:
+    std::ostream& out;
+    game chess_game;
+    bool running;
+    PerftTable* cache = nullptr;
+    bool analysis = true;
+
+    void printStatus();
+    std::string toLowerCase(const std::string& str);
+    bool isValidSquare(const std::string& square);
+    bool isValidMove(const std::string& move);
+    void processMove(const std::string& from, const std::string& to);
+    void processShow(const std::string& square);
+    void processPromotion(const std::string& piece);
+    void processCommand(const std::string& input);
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "board.hpp"
 
-#include <algorithm>
+#include <cctype>
+#include <sstream>
 #include <string>
 
 #include "utility.hpp"
@@ -13,45 +14,67 @@ std::vector<std::pair<int, char>> pieceCharPairs = {
     {NONE, ' '}, {PAWN, 'P'},  {KNIGHT, 'k'}, {BISHOP, 'B'},
     {ROOK, 'R'}, {QUEEN, 'Q'}, {KING, 'K'}};
 
-game::game()
+// Zobrist keys per square and piece value (flags included, since MOVED and
+// DOUBLESTEP change which moves are possible)
+static std::array<std::array<uint64_t, 128>, 64> makeZobristKeys() {
+  std::array<std::array<uint64_t, 128>, 64> keys;
+  uint64_t seed = 0x9E3779B97F4A7C15ull;
+  for (auto& square : keys) {
+    for (auto& key : square) {
+      // splitmix64, fixed seed so keys are identical between runs
+      uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      key = z ^ (z >> 31);
+    }
+  }
+  return keys;
+}
+
+const std::array<std::array<uint64_t, 128>, 64> zobristKeys = makeZobristKeys();
+const uint64_t zobristBlackToMove = 0xF3A9C1E5B7D20468ull;
+
+game::game(std::ostream& out)
     : isWhite(true),
       isWhitesTurn(true),
       cellSelected(false),
-      whiteDirection(-1),
-      pendingPromotion(false) {
+      pendingPromotion(false),
+      out(&out) {
   for (size_t i = 0; i < 8; i++) {  // ROW
-    std::vector<int> column;
+    const std::vector<int>* column;
     if (i == 0 || i == 7) {
-      column = kingRow;
+      column = &kingRow;
     } else if (i == 1 || i == 6) {
-      column = pawnRow;
+      column = &pawnRow;
     } else {
-      column = emptyRow;
+      column = &emptyRow;
     }
 
     for (size_t j = 0; j < 8; j++) {  // COLUMN
+      board[i][j] = (*column)[j];
       if (i == 0 || i == 1) {
-        setBit(column[j], BLACK);
+        setBit(board[i][j], BLACK);
       }
       if (i == 6 || i == 7) {
-        setBit(column[j], WHITE);
+        setBit(board[i][j], WHITE);
       }
     }
-
-    board.push_back(column);
   }
 }
 
 void game::readBoard(bool id) {
-  for (size_t i = 0; i < board.size(); i++) {  // ROW
+  for (int i = 0; i < 8; i++) {  // DISPLAY ROW
     if (isWhite)
-      std::cout << "[" << 8 - i << "]";
+      *out << "[" << 8 - i << "]";
     else
-      std::cout << "[" << i + 1 << "]";
-    for (size_t j = 0; j < board[i].size(); j++) {  // COLUMN
+      *out << "[" << i + 1 << "]";
+    for (int j = 0; j < 8; j++) {  // DISPLAY COLUMN
+      // The board is stored from white's side, only the view is rotated
+      int r = isWhite ? i : 7 - i;
+      int c = isWhite ? j : 7 - j;
 
       char pieceChar;
-      int pieceType = (board[i][j] & TYPE);
+      int pieceType = (board[r][c] & TYPE);
       bool move = false;
       bool capture = false;
 
@@ -60,7 +83,7 @@ void game::readBoard(bool id) {
         int selectedColumn = selectedCell.second;
         auto selectedType = (board[selectedRow][selectedColumn] & TYPE);
         for (auto& [row, column] : moves) {
-          if (row != i || column != j) continue;
+          if (row != r || column != c) continue;
           move = true;
 
           // Normal Capture
@@ -78,20 +101,22 @@ void game::readBoard(bool id) {
       else if (move)
         pieceChar = '#';
       else if (id)
-        pieceChar = char(board[i][j]);
+        pieceChar = char(board[r][c]);
       else
         pieceChar = getPieceChar(pieceType);
 
-      std::cout << "[" << pieceChar << "]";
+      *out << "[" << pieceChar << "]";
     }
-    std::cout << std::endl;
+    *out << std::endl;
   }
 
   // BOTTOM OF THE BOARD
   char turnChar = isWhitesTurn ? 'W' : 'B';
   char sideChar = isWhite ? 'W' : 'B';
-  std::cout << "[" << turnChar << "][A][B][C][D][E][F][G][H][" << sideChar
-            << "]" << std::endl;
+  const char* files = isWhite ? "[A][B][C][D][E][F][G][H]"
+                              : "[H][G][F][E][D][C][B][A]";
+  *out << "[" << turnChar << "]" << files << "[" << sideChar << "]"
+            << std::endl;
 }
 
 void game::makeMove(std::string a, std::string b) {
@@ -100,49 +125,47 @@ void game::makeMove(std::string a, std::string b) {
   int firstColumn;
   int secondRow;
   int secondColumn;
-  getRowColumn(a, firstRow, firstColumn, isWhite);
-  getRowColumn(b, secondRow, secondColumn, isWhite);
+  getRowColumn(a, firstRow, firstColumn);
+  getRowColumn(b, secondRow, secondColumn);
   auto& first = board[firstRow][firstColumn];
   auto& second = board[secondRow][secondColumn];
 
   // Debugging
   bool white = (board[firstRow][firstColumn] & COLOR) == WHITE;
-  std::cout << "COLOR: " << white << std::endl;
-  std::cout << "TURN: " << isWhitesTurn << std::endl;
-  std::cout << "LEGAL WHITE: " << (isWhitesTurn && white) << std::endl;
-  std::cout << "LEGAL BLACK: " << (!isWhitesTurn && !white) << std::endl;
+  *out << "COLOR: " << white << std::endl;
+  *out << "TURN: " << isWhitesTurn << std::endl;
+  *out << "LEGAL WHITE: " << (isWhitesTurn && white) << std::endl;
+  *out << "LEGAL BLACK: " << (!isWhitesTurn && !white) << std::endl;
 
   char firstChar = getPieceChar(first & TYPE);
   char secondChar = getPieceChar(second & TYPE);
-  std::cout << "[" << firstChar << "] -> [" << secondChar << "]" << std::endl;
+  *out << "[" << firstChar << "] -> [" << secondChar << "]" << std::endl;
 
   bool isEnpassant = false;
-  auto enpassantCell = board[firstRow][secondColumn];
   bool isLegalMove =
       isMoveLegal(firstRow, firstColumn, secondRow, secondColumn, isEnpassant);
 
-  std::cout << "LEGAL: " << isLegalMove << std::endl;
+  *out << "LEGAL: " << isLegalMove << std::endl;
   if (!isLegalMove) return;
-  if (isEnpassant)
-    applyMove(firstRow, firstColumn, firstRow, secondColumn);
-  else
-    applyMove(firstRow, firstColumn, secondRow, secondColumn);
+  if (isEnpassant) board[firstRow][secondColumn] = NONE;
+  applyMove(firstRow, firstColumn, secondRow, secondColumn);
 }
 
 std::vector<std::pair<int, int>> game::getPossibleMoves(int fr, int fc,
                                                         int cell) {
   std::vector<std::pair<int, int>> moves;
   int cellColor = cell & COLOR;
+  bool hasMoved = hasBit(cell, MOVED);
   excludeBits(cell, TYPE);
 
-  // pawn direction
-  int dir = whiteDirection;
+  // pawn direction, white always starts on rows 6 and 7
+  int dir = (cellColor == WHITE) ? -1 : 1;
 
   if (cell == PAWN) {
     // FORWARD
     int sr = fr;
     int sc = fc;
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < (hasMoved ? 1 : 2); i++) {
       sr += dir;
       if (sr < 0 || sr >= 8) break;
       moves.push_back({sr, sc});
@@ -170,7 +193,7 @@ std::vector<std::pair<int, int>> game::getPossibleMoves(int fr, int fc,
         // Vertical Displacement
         sr = fr + d2;
         sc = fc + d1;
-        if (sr >= 0 && sr < 8 && sc >= 0 && sc < 8 && board[sr][sc] == NONE)
+        if (sr >= 0 && sr < 8 && sc >= 0 && sc < 8)
           moves.push_back({sr, sc});
       }
     }
@@ -264,7 +287,7 @@ std::vector<std::pair<int, int>> game::getPossibleMoves(int fr, int fc,
 void game::showMoves(std::string cell) {
   int firstColumn;
   int firstRow;
-  getRowColumn(cell, firstRow, firstColumn, isWhite);
+  getRowColumn(cell, firstRow, firstColumn);
 
   moves = getPossibleMoves(firstRow, firstColumn, board[firstRow][firstColumn]);
   selectedCell = {firstRow, firstColumn};
@@ -272,15 +295,15 @@ void game::showMoves(std::string cell) {
 
   // DEBUGGING
   {
-    std::cout << firstRow << ", " << firstColumn << std::endl;
+    *out << firstRow << ", " << firstColumn << std::endl;
     for (auto& [r, c] : moves) {
-      std::cout << "[" << r << ", " << c << "]";
+      *out << "[" << r << ", " << c << "]";
     }
-    std::cout << std::endl;
+    *out << std::endl;
     int piece = board[firstRow][firstColumn];
     int pieceType = (piece & TYPE);
     char pieceChar = getPieceChar(pieceType);
-    std::cout << firstRow << ", " << firstColumn << ": [" << pieceChar
+    *out << firstRow << ", " << firstColumn << ": [" << pieceChar
               << "] WHITE: " << (piece & WHITE)
               << " DOUBLESTEP: " << (piece & DOUBLESTEP)
               << " MOVED: " << (piece & MOVED) << " piece: " << piece
@@ -288,7 +311,7 @@ void game::showMoves(std::string cell) {
   }
 }
 
-void game::getRowColumn(std::string cell, int& row, int& column, bool isWhite) {
+void game::getRowColumn(std::string cell, int& row, int& column) {
   row = 0;
   column = 0;
 
@@ -300,15 +323,10 @@ void game::getRowColumn(std::string cell, int& row, int& column, bool isWhite) {
     return;
   }
 
-  // Set Variables
-  if (isWhite) {
-    column = std::tolower(cell[0]) - 97;
-    row = 8 - (cell[1] - 49 + 1);
-  } else {
-    column = 7 - (std::tolower(cell[0]) - 97);
-    row = cell[1] - 49;
-  }
-  std::cout << "X: " << column << " Y: " << row << std::endl;
+  // Set Variables (squares are absolute, the view does not matter)
+  column = std::tolower(cell[0]) - 97;
+  row = 8 - (cell[1] - 49 + 1);
+  *out << "X: " << column << " Y: " << row << std::endl;
 
   // Bound Checks
   if (column > 7 || row > 7) {
@@ -335,25 +353,8 @@ int game::getPieceType(char pieceChar) {
 }
 
 void game::changeColor() {
+  // Only the perspective changes, the position is left untouched
   isWhite = !isWhite;
-  whiteDirection *= -1;
-
-  // ROTATE BOARD
-  std::reverse(board.begin(), board.end());
-
-  for (auto& row : board) {
-    std::reverse(row.begin(), row.end());
-  }
-
-  auto& selFirst = selectedCell.first;
-  auto& selSecond = selectedCell.second;
-  auto& selCell = board[selFirst][selSecond];
-
-  // ROTATED SELECTED CELL
-  selFirst = 7 - selFirst;
-  selSecond = 7 - selSecond;
-
-  moves = getPossibleMoves(selFirst, selSecond, selCell);
 }
 
 void game::promote(std::string piece) {
@@ -362,12 +363,16 @@ void game::promote(std::string piece) {
   char pieceChar = piece[0];
   int pieceBitMask = getPieceType(pieceChar);
 
-  if (pieceBitMask == 0) return;
+  if (pieceBitMask <= 0) return;
 
+  finishPromotion(pieceBitMask);
+}
+
+void game::finishPromotion(int pieceType) {
   auto& promotionCell =
       board[pendingPromotionCell.first][pendingPromotionCell.second];
   removeBit(promotionCell, TYPE);
-  setBit(promotionCell, pieceBitMask);
+  setBit(promotionCell, pieceType);
   pendingPromotion = false;
 
   isWhitesTurn = !isWhitesTurn;
@@ -388,6 +393,14 @@ bool game::isMoveLegal(int fr, int fc, int sr, int sc, bool& isEnpassant) {
     }
   }
 
+  isEnpassant = false;
+  if (!isLegalMove) return false;
+
+  return followsRules(fr, fc, sr, sc, isEnpassant);
+}
+
+bool game::followsRules(int fr, int fc, int sr, int sc, bool& isEnpassant) {
+  bool isLegalMove = true;
   auto& first = board[fr][fc];
   auto& second = board[sr][sc];
 
@@ -400,30 +413,28 @@ bool game::isMoveLegal(int fr, int fc, int sr, int sc, bool& isEnpassant) {
   if (pendingPromotion) isLegalMove = false;
 
   // Attacking same color pieces
-  int firstColor = first;
-  int secondColor = second;
-  excludeBits(fc, COLOR);
-  excludeBits(sc, COLOR);
-  if (fc != 0 && sc != 0 && fc == sc) isLegalMove = false;
+  int firstColor = first & COLOR;
+  int secondColor = second & COLOR;
+  bool takesNone = (second & TYPE) == NONE;
+  if (!takesNone && firstColor == secondColor) isLegalMove = false;
 
   // ENPASSANT AND FALSE CAPTURE
   auto& enpassant = board[fr][sc];
   isEnpassant = false;
   bool isPawn = (first & TYPE) == PAWN;
-  bool takesNone = (second & TYPE) == NONE || (second & COLOR) == fc;
-  bool diffTypes = isPawn && takesNone;
-  bool enpassantTaken = (enpassant & TYPE) != NONE &&
-                        (enpassant & COLOR) != fc &&
+  bool enpassantTaken = (enpassant & TYPE) == PAWN &&
+                        (enpassant & COLOR) != firstColor &&
                         (enpassant & DOUBLESTEP) != 0;
   bool diffCols = fc != sc;
 
-  if (isPawn && diffCols) {
-    if (!takesNone)
-      isLegalMove = true;
-    else if (takesNone && !enpassantTaken)
-      isLegalMove = false;
-    else
+  // Pawns only capture diagonally
+  if (isPawn && !diffCols && !takesNone) isLegalMove = false;
+
+  if (isPawn && diffCols && takesNone) {
+    if (enpassantTaken)
       isEnpassant = true;
+    else
+      isLegalMove = false;
   }
 
   return isLegalMove;
@@ -433,9 +444,13 @@ void game::applyMove(int firstRow, int firstColumn, int secondRow,
                      int secondColumn) {
   auto& first = board[firstRow][firstColumn];
   auto firstType = first & TYPE;
+  auto firstColor = first & COLOR;
   auto& second = board[secondRow][secondColumn];
-  auto secondType = second & TYPE;
-  auto secondColor = second & COLOR;
+
+  // En passant is only possible right after the double step
+  for (auto& row : board) {
+    for (auto& cell : row) removeBit(cell, DOUBLESTEP);
+  }
 
   second = first;
   first = NONE;
@@ -446,11 +461,9 @@ void game::applyMove(int firstRow, int firstColumn, int secondRow,
   if (abs(firstRow - secondRow) == 2 && firstType == PAWN)
     setBit(second, DOUBLESTEP);
 
-  // Check for Promotion
-  if (secondType == PAWN) {
-    int lastRow =
-        (secondColor != BLACK) ? (whiteDirection * 7) : (-whiteDirection * 7);
-    lastRow = std::clamp(lastRow, 0, 7);
+  // Check for Promotion, the turn passes once the piece is chosen
+  if (firstType == PAWN) {
+    int lastRow = (firstColor != BLACK) ? 0 : 7;
 
     if (secondRow == lastRow) {
       pendingPromotion = true;
@@ -458,9 +471,177 @@ void game::applyMove(int firstRow, int firstColumn, int secondRow,
     }
   }
 
-  isWhitesTurn = !isWhitesTurn;
+  if (!pendingPromotion) isWhitesTurn = !isWhitesTurn;
 
   moves.clear();
 
   checkCheckmate();
 }
+
+std::vector<Move> game::generateMoves() {
+  std::vector<Move> legalMoves;
+  if (pendingPromotion) return legalMoves;
+
+  int color = isWhitesTurn ? WHITE : BLACK;
+  for (int fr = 0; fr < 8; fr++) {
+    for (int fc = 0; fc < 8; fc++) {
+      int piece = board[fr][fc];
+      if ((piece & TYPE) == NONE || (piece & COLOR) != color) continue;
+
+      int lastRow = (color == WHITE) ? 0 : 7;
+      for (auto& [sr, sc] : getPossibleMoves(fr, fc, piece)) {
+        bool isEnpassant = false;
+        if (!followsRules(fr, fc, sr, sc, isEnpassant)) continue;
+
+        if ((piece & TYPE) == PAWN && sr == lastRow) {
+          for (int type : {QUEEN, ROOK, BISHOP, KNIGHT})
+            legalMoves.push_back({fr, fc, sr, sc, false, type});
+        } else {
+          legalMoves.push_back({fr, fc, sr, sc, isEnpassant, NONE});
+        }
+      }
+    }
+  }
+
+  return legalMoves;
+}
+
+void game::playMove(const Move& move) {
+  if (move.enpassant) board[move.fr][move.sc] = NONE;
+  applyMove(move.fr, move.fc, move.sr, move.sc);
+  if (pendingPromotion) finishPromotion(move.promotion);
+}
+
+uint64_t game::hashKey() const {
+  uint64_t key = isWhitesTurn ? 0 : zobristBlackToMove;
+  for (int r = 0; r < 8; r++) {
+    for (int c = 0; c < 8; c++) {
+      int piece = board[r][c];
+      if (piece != NONE) key ^= zobristKeys[r * 8 + c][piece & 0x7f];
+    }
+  }
+  return key;
+}
+
+bool game::canCaptureKing() {
+  int color = isWhitesTurn ? WHITE : BLACK;
+  for (int r = 0; r < 8; r++) {
+    for (int c = 0; c < 8; c++) {
+      int piece = board[r][c];
+      if ((piece & TYPE) == KING && (piece & COLOR) != color)
+        return isAttacked(r, c, color);
+    }
+  }
+
+  return false;
+}
+
+// Looks outward from the square instead of generating every move, the
+// patterns match getPossibleMoves
+bool game::isAttacked(int row, int column, int byColor) const {
+  auto holds = [&](int r, int c, int type) {
+    if (r < 0 || r >= 8 || c < 0 || c >= 8) return false;
+    return (board[r][c] & TYPE) == type && (board[r][c] & COLOR) == byColor;
+  };
+
+  // Pawns capture towards the square from one row behind it
+  int dir = (byColor == WHITE) ? -1 : 1;
+  if (holds(row - dir, column - 1, PAWN) || holds(row - dir, column + 1, PAWN))
+    return true;
+
+  for (auto d1 : {-1, 1}) {
+    for (auto d2 : {-2, 2}) {
+      if (holds(row + d1, column + d2, KNIGHT) ||
+          holds(row + d2, column + d1, KNIGHT))
+        return true;
+    }
+  }
+
+  for (auto d1 : {-1, 0, 1}) {
+    for (auto d2 : {-1, 0, 1}) {
+      if ((d1 || d2) && holds(row + d1, column + d2, KING)) return true;
+    }
+  }
+
+  // Sliders, diagonals for bishops and orthogonals for rooks
+  for (auto d1 : {-1, 0, 1}) {
+    for (auto d2 : {-1, 0, 1}) {
+      if (!d1 && !d2) continue;
+      int slider = (d1 && d2) ? BISHOP : ROOK;
+      int r = row + d1;
+      int c = column + d2;
+      while (r >= 0 && r < 8 && c >= 0 && c < 8) {
+        if ((board[r][c] & TYPE) != NONE) {
+          if (holds(r, c, slider) || holds(r, c, QUEEN)) return true;
+          break;
+        }
+        r += d1;
+        c += d2;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool game::inCheck() {
+  game opponent = *this;
+  opponent.isWhitesTurn = !isWhitesTurn;
+  return opponent.canCaptureKing();
+}
+
+bool game::loadFen(const std::string& fen) {
+  std::istringstream iss(fen);
+  std::string placement, side, castling, enpassant;
+  if (!(iss >> placement >> side)) return false;
+  iss >> castling >> enpassant;
+
+  std::array<std::array<int, 8>, 8> position;
+  for (auto& row : position) row.fill(NONE);
+
+  int r = 0;
+  int c = 0;
+  for (char ch : placement) {
+    if (ch == '/') {
+      if (c != 8) return false;
+      r++;
+      c = 0;
+    } else if (std::isdigit(ch)) {
+      c += ch - '0';
+    } else {
+      const std::string letters = "pnbrqk";
+      auto index = letters.find(std::tolower(ch));
+      if (index == std::string::npos || r > 7 || c > 7) return false;
+
+      int piece = int(index) + PAWN;
+      setBit(piece, std::isupper(ch) ? WHITE : BLACK);
+
+      // Pawns off their start row can no longer double step
+      int startRow = std::isupper(ch) ? 6 : 1;
+      if ((piece & TYPE) == PAWN && r != startRow) setBit(piece, MOVED);
+
+      position[r][c++] = piece;
+    }
+    if (c > 8) return false;
+  }
+  if (r != 7 || c != 8) return false;
+  if (side != "w" && side != "b") return false;
+
+  board = position;
+  isWhitesTurn = side == "w";
+  pendingPromotion = false;
+  cellSelected = false;
+  moves.clear();
+
+  // The pawn that just double stepped sits behind the en passant square
+  if (enpassant.size() == 2 && enpassant[0] >= 'a' && enpassant[0] <= 'h' &&
+      (enpassant[1] == '3' || enpassant[1] == '6')) {
+    int column = enpassant[0] - 'a';
+    int row = 8 - (enpassant[1] - '0');
+    row += isWhitesTurn ? 1 : -1;
+    auto& pawn = board[row][column];
+    if ((pawn & TYPE) == PAWN) setBit(pawn, DOUBLESTEP);
+  }
+
+  return true;
+}
@@ -0,0 +1,318 @@
+#include "mate.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "perft.hpp"
+
+namespace {
+constexpr uint32_t INFINITE = 1u << 30;
+constexpr size_t NODE_LIMIT = 1000000;
+
+// Mate results share the cache with perft counts, this keeps them apart
+constexpr uint64_t MATE_SALT = 0x6D617465536F6C76ull;  // "mateSolv"
+
+// Result and first move packed into the value a cache entry holds
+uint64_t packResult(const MateResult& result) {
+  const Move& move = result.firstMove;
+  return uint64_t(result.mate) | uint64_t(move.fr) << 1 |
+         uint64_t(move.fc) << 4 | uint64_t(move.sr) << 7 |
+         uint64_t(move.sc) << 10 | uint64_t(move.enpassant) << 13 |
+         uint64_t(move.promotion) << 14;
+}
+
+MateResult unpackResult(uint64_t value) {
+  MateResult result;
+  result.mate = value & 1;
+  result.cached = true;
+  if (result.mate) {
+    result.firstMove = {int(value >> 1 & 7),  int(value >> 4 & 7),
+                        int(value >> 7 & 7),  int(value >> 10 & 7),
+                        bool(value >> 13 & 1), int(value >> 14 & 7)};
+  }
+  return result;
+}
+
+// Looks the position up first, and stores whatever the search settles
+MateResult solveCached(const game& position, int moves, PerftTable* cache) {
+  uint64_t key = position.hashKey() ^ MATE_SALT;
+  uint64_t value = 0;
+  if (cache && cache->probe(key, moves, value)) return unpackResult(value);
+
+  MateSolver solver(position, moves, NODE_LIMIT);
+  MateResult result = solver.solve();
+  if (cache && !result.unknown) cache->store(key, moves, packResult(result));
+  return result;
+}
+
+uint32_t saturatingAdd(uint32_t a, uint32_t b) {
+  return std::min(a + b, INFINITE);
+}
+
+std::string moveString(const Move& move) {
+  std::string text;
+  text += char('a' + move.fc);
+  text += char('8' - move.fr);
+  text += char('a' + move.sc);
+  text += char('8' - move.sr);
+  if (move.promotion != NONE) text += " pnbrqk"[move.promotion];
+  return text;
+}
+
+void printResult(const std::string& id, int moves, const MateResult& result,
+                 std::ostream& out) {
+  out << id << ": ";
+  if (result.mate)
+    out << "mate in " << moves << " with " << moveString(result.firstMove);
+  else if (result.unknown)
+    out << "unknown, node limit reached";
+  else
+    out << "no mate in " << moves;
+  if (result.cached)
+    out << " | from cache";
+  else
+    out << " | nodes: " << result.nodes << " | time: " << result.seconds
+        << "s";
+  out << std::endl;
+}
+}  // namespace
+
+MateSolver::MateSolver(const game& root, int moves, size_t nodeLimit)
+    : root(root), plies(2 * moves - 1), nodeLimit(nodeLimit) {}
+
+MateResult MateSolver::solve() {
+  auto start = std::chrono::steady_clock::now();
+
+  nodes.clear();
+  table.clear();
+  nodes.push_back({Move{}, root.hashKey(), 1, 1, -1, -1, 0, false});
+
+  while (nodes[0].proof != 0 && nodes[0].disproof != 0 &&
+         nodes.size() < nodeLimit) {
+    // Follow the most proving path down to a leaf
+    game position = root;
+    int index = 0;
+    int depth = plies;
+    bool attacker = true;
+    while (nodes[index].expanded) {
+      const Node& node = nodes[index];
+      int best = node.firstChild;
+      for (int i = node.firstChild; i < node.firstChild + node.childCount;
+           i++) {
+        if (attacker ? nodes[i].proof < nodes[best].proof
+                     : nodes[i].disproof < nodes[best].disproof)
+          best = i;
+      }
+
+      position.playMove(nodes[best].move);
+      index = best;
+      depth--;
+      attacker = !attacker;
+    }
+
+    expand(index, position, depth, attacker);
+    update(index, attacker);
+  }
+
+  MateResult result;
+  result.mate = nodes[0].proof == 0;
+  result.unknown = nodes[0].proof != 0 && nodes[0].disproof != 0;
+  result.nodes = nodes.size();
+  if (result.mate) {
+    for (int i = 0; i < nodes[0].childCount; i++) {
+      const Node& child = nodes[nodes[0].firstChild + i];
+      if (child.proof == 0) {
+        result.firstMove = child.move;
+        break;
+      }
+    }
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+void MateSolver::expand(int index, game& position, int depth, bool attacker) {
+  nodes[index].expanded = true;
+
+  // Keep only moves that do not leave the own king capturable
+  std::vector<std::pair<Move, uint64_t>> legal;
+  for (auto& move : position.generateMoves()) {
+    game child = position;
+    child.playMove(move);
+    if (child.canCaptureKing()) continue;
+    legal.push_back({move, child.hashKey()});
+  }
+
+  Node& node = nodes[index];
+  if (legal.empty()) {
+    // Mate only counts when it is the defender who has no moves left
+    bool mated = !attacker && position.inCheck();
+    node.proof = mated ? 0 : INFINITE;
+    node.disproof = mated ? INFINITE : 0;
+    return;
+  }
+  if (depth == 0) {
+    node.proof = INFINITE;
+    node.disproof = 0;
+    return;
+  }
+
+  node.firstChild = int(nodes.size());
+  node.childCount = int(legal.size());
+  for (auto& [move, key] : legal) {
+    Node child{move, key, 1, 1, index, -1, 0, false};
+
+    // Reuse what is already known about this position at this depth
+    auto known = table.find(key);
+    if (known != table.end()) {
+      if (known->second.proven <= depth - 1) {
+        child.proof = 0;
+        child.disproof = INFINITE;
+        child.expanded = true;
+      } else if (known->second.disproven >= depth - 1) {
+        child.proof = INFINITE;
+        child.disproof = 0;
+        child.expanded = true;
+      }
+    }
+    nodes.push_back(child);
+  }
+}
+
+void MateSolver::update(int index, bool attacker) {
+  int depth = plies;
+  for (int i = index; i > 0; i = nodes[i].parent) depth--;
+
+  while (index != -1) {
+    Node& node = nodes[index];
+    if (node.childCount > 0) {
+      uint32_t proof = attacker ? INFINITE : 0;
+      uint32_t disproof = attacker ? 0 : INFINITE;
+      for (int i = node.firstChild; i < node.firstChild + node.childCount;
+           i++) {
+        if (attacker) {
+          proof = std::min(proof, nodes[i].proof);
+          disproof = saturatingAdd(disproof, nodes[i].disproof);
+        } else {
+          proof = saturatingAdd(proof, nodes[i].proof);
+          disproof = std::min(disproof, nodes[i].disproof);
+        }
+      }
+      node.proof = proof;
+      node.disproof = disproof;
+    }
+
+    if (node.proof == 0 || node.disproof == 0)
+      remember(node.key, depth, node.proof == 0);
+
+    index = node.parent;
+    attacker = !attacker;
+    depth++;
+  }
+}
+
+void MateSolver::remember(uint64_t key, int depth, bool proven) {
+  auto [entry, inserted] = table.try_emplace(key, Known{INFINITE, -1});
+  if (proven)
+    entry->second.proven = std::min(entry->second.proven, depth);
+  else
+    entry->second.disproven = std::max(entry->second.disproven, depth);
+}
+
+void runMate(const game& position, int moves, std::ostream& out,
+             PerftTable* cache) {
+  printResult("position", moves, solveCached(position, moves, cache), out);
+}
+
+void runMateFile(const std::string& path, int moves, int threads,
+                 std::ostream& out, PerftTable* cache) {
+  std::ifstream file(path);
+  if (!file) {
+    out << "❌ Cannot open " << path << std::endl;
+    return;
+  }
+
+  struct Puzzle {
+    std::string id;
+    game position;
+    int moves;
+    MateResult result;
+  };
+
+  // EPD: four FEN fields followed by opcodes such as 'dm 2; id "x";'
+  std::vector<Puzzle> puzzles;
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(file, line)) {
+    lineNumber++;
+    std::istringstream iss(line);
+    std::string placement, side, castling, enpassant;
+    if (!(iss >> placement >> side >> castling >> enpassant)) continue;
+
+    Puzzle puzzle{"#" + std::to_string(puzzles.size() + 1), game(out), moves,
+                  {}};
+    if (!puzzle.position.loadFen(placement + " " + side + " " + castling +
+                                 " " + enpassant)) {
+      out << "❌ Line " << lineNumber << ": invalid position, skipped"
+          << std::endl;
+      continue;
+    }
+
+    bool valid = true;
+    std::string opcode;
+    while (iss >> opcode) {
+      std::string operand;
+      std::getline(iss, operand, ';');
+      operand.erase(0, operand.find_first_not_of(" \"'"));
+      operand.erase(operand.find_last_not_of(" \"'") + 1);
+      if (opcode == "id") puzzle.id = operand;
+      if (opcode == "dm") {
+        std::istringstream number(operand);
+        char extra;
+        valid = (number >> puzzle.moves) && !(number >> extra) &&
+                puzzle.moves >= 1 && puzzle.moves <= MAX_MATE_MOVES;
+        if (!valid) break;
+      }
+    }
+    if (!valid) {
+      out << "❌ Line " << lineNumber << ": dm must be 1-" << MAX_MATE_MOVES
+          << ", skipped" << std::endl;
+      continue;
+    }
+    puzzles.push_back(puzzle);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  // Puzzles are independent, each thread takes the next unsolved one
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next.fetch_add(1)) < puzzles.size()) {
+      puzzles[i].result =
+          solveCached(puzzles[i].position, puzzles[i].moves, cache);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; i++) pool.emplace_back(worker);
+  for (auto& thread : pool) thread.join();
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  size_t solved = 0;
+  for (auto& puzzle : puzzles) {
+    printResult(puzzle.id, puzzle.moves, puzzle.result, out);
+    if (puzzle.result.mate) solved++;
+  }
+  out << "Mates found: " << solved << "/" << puzzles.size() << " | " << threads
+      << " threads | total time: " << seconds << "s" << std::endl;
+}
@@ -0,0 +1,247 @@
+#include "perft.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// Bump when the layout, rules or Zobrist keys change
+constexpr uint64_t CACHE_MAGIC = 0x33305446524550ull;  // "PERFT03"
+
+// The same position counted to several depths should not share one slot
+constexpr uint64_t DEPTH_MIX = 0x9E3779B97F4A7C15ull;
+
+// Keeps the byte size computations below far from overflowing
+constexpr size_t MAX_MEGABYTES = 1 << 16;  // 64 GB
+
+// Positions after each legal move, moves leaving the king capturable are
+// dropped the same way the mate solver does
+std::vector<game> legalChildren(const game& position) {
+  game parent = position;
+  std::vector<game> children;
+  for (auto& move : parent.generateMoves()) {
+    game child = parent;
+    child.playMove(move);
+    if (!child.canCaptureKing()) children.push_back(child);
+  }
+  return children;
+}
+
+size_t entryCount(size_t megabytes, size_t entrySize) {
+  size_t bytes = std::min(megabytes, MAX_MEGABYTES) * 1024 * 1024;
+  size_t count = 1;
+  while (count * 2 * entrySize <= bytes) count *= 2;
+  return count;
+}
+}  // namespace
+
+PerftTable::PerftTable(size_t megabytes)
+    : storage(entryCount(megabytes, sizeof(Entry))) {
+  entries = storage.data();
+  mask = storage.size() - 1;
+}
+
+PerftTable::PerftTable(const std::string& path, size_t megabytes) {
+  int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    throw std::runtime_error(path + ": " + std::strerror(errno));
+
+  // Start a new cache only in a new or empty file, never overwrite others
+  FileHeader header{};
+  struct stat info {};
+  if (fstat(fd, &info) < 0) {
+    close(fd);
+    throw std::runtime_error(path + ": " + std::strerror(errno));
+  }
+  if (info.st_size == 0) {
+    header = {CACHE_MAGIC, entryCount(megabytes, sizeof(Entry)), 0};
+    if (ftruncate(fd, sizeof(FileHeader) + header.count * sizeof(Entry)) < 0) {
+      close(fd);
+      throw std::runtime_error(path + ": " + std::strerror(errno));
+    }
+  } else {
+    // Bound count by the file size before multiplying, so a forged header
+    // cannot wrap the size check
+    size_t fileSize = size_t(info.st_size);
+    bool valid = fileSize >= sizeof(FileHeader) &&
+                 pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+                 header.magic == CACHE_MAGIC && header.count != 0 &&
+                 (header.count & (header.count - 1)) == 0 &&
+                 header.count <=
+                     (fileSize - sizeof(FileHeader)) / sizeof(Entry) &&
+                 fileSize == sizeof(FileHeader) + header.count * sizeof(Entry);
+    if (!valid) {
+      close(fd);
+      throw std::runtime_error(path + ": not a perft cache");
+    }
+  }
+
+  mappingSize = sizeof(FileHeader) + header.count * sizeof(Entry);
+  mapping =
+      mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw std::runtime_error(path + ": " + std::strerror(errno));
+  }
+
+  // Every session is a new generation
+  header.generation++;
+  std::memcpy(mapping, &header, sizeof(header));
+
+  entries = reinterpret_cast<Entry*>(static_cast<char*>(mapping) +
+                                     sizeof(FileHeader));
+  mask = header.count - 1;
+  age = uint32_t(header.generation);
+}
+
+PerftTable::~PerftTable() {
+  if (mapping) munmap(mapping, mappingSize);
+}
+
+size_t PerftTable::slot(uint64_t key, int depth) const {
+  return (key ^ (uint64_t(depth) * DEPTH_MIX)) & mask;
+}
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& nodes) const {
+  const Entry& entry = entries[slot(key, depth)];
+  uint64_t count = entry.nodes.load(std::memory_order_relaxed);
+  uint64_t info = entry.info.load(std::memory_order_relaxed);
+  uint64_t check = entry.check.load(std::memory_order_relaxed);
+  if ((check ^ count ^ info) != key || int(info & 0xff) != depth)
+    return false;
+
+  nodes = count;
+  return true;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t nodes) {
+  Entry& entry = entries[slot(key, depth)];
+
+  // Keep deeper subtrees, unless they are left over from an older session
+  // (32 bit ages only repeat after 2^32 sessions)
+  uint64_t old = entry.info.load(std::memory_order_relaxed);
+  int oldDepth = int(old & 0xff);
+  uint32_t oldAge = uint32_t(old >> 8);
+  if (old != 0 && oldAge == age && oldDepth > depth) return;
+
+  uint64_t info = (uint64_t(age) << 8) | uint64_t(depth);
+  entry.check.store(key ^ nodes ^ info, std::memory_order_relaxed);
+  entry.nodes.store(nodes, std::memory_order_relaxed);
+  entry.info.store(info, std::memory_order_relaxed);
+}
+
+uint64_t perft(game& position, int depth, PerftTable* table) {
+  if (depth == 0) return 1;
+
+  auto children = legalChildren(position);
+  if (depth == 1) return children.size();
+
+  uint64_t key = 0;
+  uint64_t nodes = 0;
+  if (table) {
+    key = position.hashKey();
+    if (table->probe(key, depth, nodes)) return nodes;
+  }
+
+  for (auto& child : children) nodes += perft(child, depth - 1, table);
+
+  if (table) table->store(key, depth, nodes);
+  return nodes;
+}
+
+uint64_t parallelPerft(const game& position, int depth, int threads,
+                       PerftTable& table) {
+  if (depth < 3) {
+    game root = position;
+    return perft(root, depth, &table);
+  }
+
+  // Positions analysed before (possibly in an earlier session) return here
+  uint64_t key = position.hashKey();
+  uint64_t cached = 0;
+  if (table.probe(key, depth, cached)) return cached;
+
+  // Every root move and reply becomes a task, which gives enough of them to
+  // keep all threads busy even when a few subtrees are much larger
+  std::vector<game> tasks;
+  for (auto& child : legalChildren(position)) {
+    for (auto& grandchild : legalChildren(child)) tasks.push_back(grandchild);
+  }
+
+  // Idle threads grab the next unclaimed task
+  std::atomic<size_t> next{0};
+  std::atomic<uint64_t> total{0};
+  auto worker = [&]() {
+    size_t i;
+    while ((i = next.fetch_add(1)) < tasks.size()) {
+      total += perft(tasks[i], depth - 2, &table);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 0; i < threads; i++) pool.emplace_back(worker);
+  for (auto& thread : pool) thread.join();
+
+  table.store(key, depth, total);
+  return total;
+}
+
+void runPerft(const game& position, int depth, int threads, bool compare,
+              std::ostream& out, PerftTable* cache) {
+  using clock = std::chrono::steady_clock;
+
+  auto seconds = [](clock::time_point start) {
+    return std::chrono::duration<double>(clock::now() - start).count();
+  };
+
+  // Positions counted before, possibly in an earlier session
+  auto start = clock::now();
+  uint64_t cached = 0;
+  if (cache && cache->probe(position.hashKey(), depth, cached)) {
+    out << "perft(" << depth << ") = " << cached
+        << " | from cache: " << seconds(start) << "s" << std::endl;
+    return;
+  }
+
+  uint64_t nodes = 0;
+  double serialTime = 0;
+  if (compare) {
+    start = clock::now();
+    game root = position;
+    nodes = perft(root, depth, nullptr);
+    serialTime = seconds(start);
+    out << "perft(" << depth << ") = " << nodes
+        << " | 1 thread, no hash: " << serialTime << "s" << std::endl;
+  }
+
+  PerftTable* table = cache;
+  std::unique_ptr<PerftTable> fresh;
+  if (!table) {
+    fresh = std::make_unique<PerftTable>(256);
+    table = fresh.get();
+  }
+
+  start = clock::now();
+  uint64_t parallelNodes = parallelPerft(position, depth, threads, *table);
+  double parallelTime = seconds(start);
+  out << "perft(" << depth << ") = " << parallelNodes << " | " << threads
+      << " threads + hash: " << parallelTime << "s";
+  if (compare) {
+    out << " | speedup (threads and hash combined): "
+        << serialTime / parallelTime << "x";
+  }
+  out << std::endl;
+
+  if (compare && nodes != parallelNodes)
+    out << "⚠️  Node counts differ!" << std::endl;
+}
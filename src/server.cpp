@@ -0,0 +1,302 @@
+#include "server.hpp"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+// Listener uses this id in the epoll data, sessions use their pool index
+constexpr int LISTENER = -1;
+constexpr int MAX_EVENTS = 256;
+
+// Per client limits, so one connection cannot take all the memory
+constexpr size_t MAX_LINE = 1024;
+constexpr size_t MAX_INPUT = 16 * 1024;
+constexpr size_t MAX_OUTPUT = 64 * 1024;
+
+void setNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+std::runtime_error systemError(const std::string& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+}  // namespace
+
+GameServer::GameServer(std::string socketPath, size_t maxSessions)
+    : socketPath(std::move(socketPath)),
+      listenFd(-1),
+      epollFd(-1),
+      sessions(maxSessions),
+      freeSession(-1) {
+  for (int i = int(sessions.size()) - 1; i >= 0; i--) {
+    sessions[i].nextFree = freeSession;
+    freeSession = i;
+  }
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (this->socketPath.size() >= sizeof(address.sun_path))
+    throw std::runtime_error("socket path too long: " + this->socketPath);
+  std::strcpy(address.sun_path, this->socketPath.c_str());
+
+  // Only a socket left behind by an earlier run may be replaced
+  struct stat info {};
+  if (lstat(this->socketPath.c_str(), &info) == 0) {
+    if (!S_ISSOCK(info.st_mode))
+      throw std::runtime_error(this->socketPath +
+                               " exists and is not a socket");
+    unlink(this->socketPath.c_str());
+  }
+
+  listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0) throw systemError("socket");
+  if (bind(listenFd, reinterpret_cast<sockaddr*>(&address),
+           sizeof(address)) < 0)
+    throw systemError("bind " + this->socketPath);
+  if (listen(listenFd, SOMAXCONN) < 0) throw systemError("listen");
+  setNonBlocking(listenFd);
+
+  epollFd = epoll_create1(0);
+  if (epollFd < 0) throw systemError("epoll_create1");
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.u64 = uint64_t(int64_t(LISTENER));
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) < 0)
+    throw systemError("epoll_ctl");
+
+  spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+GameServer::~GameServer() {
+  for (size_t i = 0; i < sessions.size(); i++) {
+    if (sessions[i].fd >= 0) close(sessions[i].fd);
+  }
+  if (epollFd >= 0) close(epollFd);
+  if (spareFd >= 0) close(spareFd);
+  if (listenFd >= 0) {
+    close(listenFd);
+    unlink(socketPath.c_str());
+  }
+}
+
+void GameServer::run() {
+  std::cout << "Serving games on " << socketPath << " (" << sessions.size()
+            << " sessions)" << std::endl;
+
+  epoll_event events[MAX_EVENTS];
+  while (true) {
+    int count = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+    if (count < 0) {
+      if (errno == EINTR) continue;
+      throw systemError("epoll_wait");
+    }
+
+    for (int i = 0; i < count; i++) {
+      int id = int(int64_t(events[i].data.u64));
+      if (id == LISTENER) {
+        acceptClients();
+        continue;
+      }
+
+      // Closed earlier in this batch, the slot is not reused until after it
+      if (sessions[id].fd < 0) continue;
+
+      // Read before handling a hangup, commands may still be buffered
+      Session& session = sessions[id];
+      if (events[i].events & EPOLLOUT) {
+        if (!flushClient(id)) continue;
+        if (session.pending.empty()) runInput(id);
+      }
+      if ((events[i].events & EPOLLIN) && session.fd >= 0) readClient(id);
+      if ((events[i].events & (EPOLLHUP | EPOLLERR)) && session.fd >= 0)
+        closeClient(id);
+    }
+
+    for (int id : closedSessions) {
+      sessions[id].nextFree = freeSession;
+      freeSession = id;
+    }
+    if (!closedSessions.empty()) watchListener(true);
+    closedSessions.clear();
+  }
+}
+
+void GameServer::acceptClients() {
+  while (true) {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      if (errno == EMFILE || errno == ENFILE) {
+        // Out of descriptors: use the spare one to turn the client away,
+        // otherwise stop listening until a session closes
+        if (spareFd < 0) {
+          watchListener(false);
+          return;
+        }
+        // (accept reports EMFILE even with an empty queue, so stop once the
+        // retry finds nobody waiting)
+        close(spareFd);
+        fd = accept(listenFd, nullptr, nullptr);
+        if (fd >= 0) close(fd);
+        spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        continue;
+      }
+      return;  // EAGAIN, nothing left to accept
+    }
+
+    // Pool exhausted, turn the client away
+    if (freeSession < 0) {
+      const char full[] = "Server is full, try again later\n";
+      send(fd, full, sizeof(full) - 1, MSG_NOSIGNAL);
+      close(fd);
+      continue;
+    }
+
+    int id = freeSession;
+    Session& session = sessions[id];
+    freeSession = session.nextFree;
+
+    setNonBlocking(fd);
+    session.ui.setAnalysis(false);
+    session.fd = fd;
+    session.nextFree = -1;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = uint64_t(id);
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+      close(fd);
+      session.fd = -1;
+      session.nextFree = freeSession;
+      freeSession = id;
+      continue;
+    }
+
+    session.ui.printWelcome();
+    session.ui.printHelp();
+    session.ui.printPrompt();
+    flushClient(id);
+  }
+}
+
+void GameServer::readClient(int id) {
+  Session& session = sessions[id];
+  if (!session.pending.empty()) return;  // Replies first, see flushClient
+
+  // Read a bounded amount, the rest waits in the socket for the next round
+  char buffer[4096];
+  while (session.input.size() < MAX_INPUT) {
+    ssize_t size = recv(session.fd, buffer, sizeof(buffer), 0);
+    if (size < 0 && errno == EINTR) continue;
+    if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+    if (size <= 0) {
+      session.hungUp = true;
+      break;
+    }
+    session.input.append(buffer, size);
+  }
+
+  runInput(id);
+}
+
+void GameServer::runInput(int id) {
+  Session& session = sessions[id];
+
+  while (true) {
+    // Run complete lines until a batch of output is ready to send
+    size_t start = 0;
+    size_t end;
+    while (session.ui.isRunning() &&
+           session.output.tellp() < std::streamoff(MAX_OUTPUT) &&
+           (end = session.input.find('\n', start)) != std::string::npos) {
+      session.ui.handleLine(session.input.substr(start, end - start));
+      start = end + 1;
+      if (session.ui.isRunning()) session.ui.printPrompt();
+    }
+    session.input.erase(0, start);
+
+    bool moreLines = session.ui.isRunning() &&
+                     session.input.find('\n') != std::string::npos;
+    if (!moreLines && session.input.size() > MAX_LINE) {
+      closeClient(id);  // No command is this long
+      return;
+    }
+
+    if (!flushClient(id)) return;
+    if (!session.pending.empty()) return;  // Resumed once the client reads
+    if (moreLines) continue;
+
+    if (session.hungUp || !session.ui.isRunning()) closeClient(id);
+    return;
+  }
+}
+
+bool GameServer::flushClient(int id) {
+  Session& session = sessions[id];
+  session.pending += session.output.str();
+  session.output.str("");
+
+  while (!session.pending.empty()) {
+    ssize_t size = send(session.fd, session.pending.data(),
+                        session.pending.size(), MSG_NOSIGNAL);
+    if (size < 0) {
+      if (errno == EINTR) continue;
+      // Stop reading from the client until it takes its replies
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        watchClient(id, true);
+        return true;
+      }
+      closeClient(id);
+      return false;
+    }
+    session.pending.erase(0, size);
+  }
+
+  watchClient(id, false);
+  return true;
+}
+
+void GameServer::watchClient(int id, bool wantWrite) {
+  epoll_event event{};
+  event.events = wantWrite ? uint32_t(EPOLLOUT) : uint32_t(EPOLLIN);
+  event.data.u64 = uint64_t(id);
+  epoll_ctl(epollFd, EPOLL_CTL_MOD, sessions[id].fd, &event);
+}
+
+void GameServer::watchListener(bool enabled) {
+  if (enabled == listening) return;
+  listening = enabled;
+
+  epoll_event event{};
+  event.events = enabled ? uint32_t(EPOLLIN) : 0u;
+  event.data.u64 = uint64_t(int64_t(LISTENER));
+  epoll_ctl(epollFd, EPOLL_CTL_MOD, listenFd, &event);
+}
+
+void GameServer::closeClient(int id) {
+  Session& session = sessions[id];
+  if (session.fd < 0) return;
+
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, session.fd, nullptr);
+  close(session.fd);
+  session.fd = -1;
+  session.input.clear();
+  session.pending.clear();
+  session.output.str("");
+  session.hungUp = false;
+  session.ui.reset();
+
+  // Freed once the current epoll batch is done
+  closedSessions.push_back(id);
+}
@@ -0,0 +1,264 @@
+#include "ui.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "mate.hpp"
+#include "perft.hpp"
+
+// Requested thread counts are capped, std::thread throws when it runs out
+static int threadCount(int requested) {
+    int cores = std::max(int(std::thread::hardware_concurrency()), 1);
+    return std::clamp(requested, 1, cores * 4);
+}
+
+ChessUI::ChessUI(std::ostream& out) : out(out), chess_game(out), running(true) {}
+
+void ChessUI::printWelcome() {
+    out << "\n╔══════════════════════════════════════╗\n";
+    out << "║            ♟️  Mate++ Chess          ║\n";
+    out << "║     Modern C++ Chess Engine         ║\n";
+    out << "╚══════════════════════════════════════╝\n\n";
+}
+
+void ChessUI::printHelp() {
+    out << "\n📖 HELP - Available Commands:\n";
+    out << "═══════════════════════════════════════\n";
+    out << "🔹 move <from><to>  - Make a move (e.g., 'move e2e4', 'e2e4')\n";
+    out << "🔹 show <square>    - Show possible moves (e.g., 'show e2', 'e2')\n";
+    out << "🔹 promote <piece>  - Promote pawn (Q/R/B/N)\n";
+    out << "🔹 flip            - Flip board perspective\n";
+    if (analysis) {
+        out << "🔹 perft <depth> [threads] [compare] - Count move paths\n";
+        out << "🔹 mate <n> [file.epd] [threads] - Find a forced mate in n moves\n";
+    }
+    out << "🔹 fen <fen>         - Load a position\n";
+    out << "🔹 board           - Display current board\n";
+    out << "🔹 help            - Show this help menu\n";
+    out << "🔹 quit/exit       - Exit the game\n\n";
+    out << "💡 Quick Tips:\n";
+    out << "   • You can type moves directly: 'e2e4' or 'move e2e4'\n";
+    out << "   • Click squares to see moves: 'e2' or 'show e2'\n";
+    out << "   • Squares: a1-h8 (letters a-h, numbers 1-8)\n\n";
+}
+
+void ChessUI::printStatus() {
+    out << "🎮 Turn: " << (chess_game.isWhitesTurn ? "⚪ White" : "⚫ Black");
+    out << " | View: " << (chess_game.isWhite ? "⚪ White" : "⚫ Black");
+    out << " | Type 'help' for commands\n";
+    out << "─────────────────────────────────────────────────────────\n";
+}
+
+std::string ChessUI::toLowerCase(const std::string& str) {
+    std::string result = str;
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+bool ChessUI::isValidSquare(const std::string& square) {
+    if (square.length() != 2) return false;
+    char file = square[0];
+    char rank = square[1];
+    return (file >= 'a' && file <= 'h') && (rank >= '1' && rank <= '8');
+}
+
+bool ChessUI::isValidMove(const std::string& move) {
+    if (move.length() != 4) return false;
+    return isValidSquare(move.substr(0, 2)) && isValidSquare(move.substr(2, 2));
+}
+
+void ChessUI::processMove(const std::string& from, const std::string& to) {
+    if (!isValidSquare(from) || !isValidSquare(to)) {
+        out << "❌ Invalid square format! Use notation like 'e2' or 'a1'\n";
+        return;
+    }
+
+    out << "Attempting move: " << from << " → " << to << "\n";
+    chess_game.makeMove(from, to);
+}
+
+void ChessUI::processShow(const std::string& square) {
+    if (!isValidSquare(square)) {
+        out << "❌ Invalid square format! Use notation like 'e2'\n";
+        return;
+    }
+
+    out << "Showing moves for: " << square << "\n";
+    chess_game.showMoves(square);
+}
+
+void ChessUI::processPromotion(const std::string& piece) {
+    if (piece.length() != 1) {
+        out << "❌ Invalid piece! Use: Q (Queen), R (Rook), B (Bishop), N (Knight)\n";
+        return;
+    }
+
+    char p = std::toupper(piece[0]);
+    if (p != 'Q' && p != 'R' && p != 'B' && p != 'N') {
+        out << "❌ Invalid piece! Use: Q (Queen), R (Rook), B (Bishop), N (Knight)\n";
+        return;
+    }
+
+    out << "👑 Promoting to: " << p << "\n";
+    chess_game.promote(std::string(1, p));
+}
+
+void ChessUI::processCommand(const std::string& input) {
+    if (input.empty()) return;
+
+    std::string command = toLowerCase(input);
+    std::istringstream iss(command);
+    std::string first_word;
+    iss >> first_word;
+
+    // Handle direct move input (e.g., "e2e4")
+    if (isValidMove(first_word)) {
+        processMove(first_word.substr(0, 2), first_word.substr(2, 2));
+        return;
+    }
+
+    // Handle direct square input (e.g., "e2")
+    if (isValidSquare(first_word)) {
+        processShow(first_word);
+        return;
+    }
+
+    // Handle single character promotion
+    if (first_word.length() == 1) {
+        char c = std::toupper(first_word[0]);
+        if (c == 'Q' || c == 'R' || c == 'B' || c == 'N') {
+            processPromotion(first_word);
+            return;
+        }
+    }
+
+    // Handle explicit commands
+    if (first_word == "move") {
+        std::string move_str;
+        iss >> move_str;
+        if (isValidMove(move_str)) {
+            processMove(move_str.substr(0, 2), move_str.substr(2, 2));
+        } else {
+            out << "❌ Invalid move format! Use: move e2e4\n";
+        }
+    }
+    else if (first_word == "show") {
+        std::string square;
+        iss >> square;
+        processShow(square);
+    }
+    else if (first_word == "promote") {
+        std::string piece;
+        iss >> piece;
+        processPromotion(piece);
+    }
+    else if (!analysis && (first_word == "perft" || first_word == "mate")) {
+        out << "❌ '" << first_word << "' is not available on the game server\n";
+    }
+    else if (first_word == "perft") {
+        int depth = 0;
+        int threads = std::thread::hardware_concurrency();
+        bool compare = false;
+        iss >> depth;
+
+        // Optional thread count and 'compare', in any order
+        std::string option;
+        while (iss >> option) {
+            if (option == "compare")
+                compare = true;
+            else if (std::all_of(option.begin(), option.end(), ::isdigit))
+                threads = std::stoi(option.substr(0, 6));
+        }
+        if (depth < 1) {
+            out << "❌ Invalid depth! Use: perft 5 [threads] [compare]\n";
+            return;
+        }
+        runPerft(chess_game, depth, threadCount(threads), compare, out, cache);
+    }
+    else if (first_word == "mate") {
+        // File names are case sensitive, so read from the raw input
+        std::istringstream args(input);
+        std::string word;
+        int moves = 0;
+        std::string path;
+        int threads = std::thread::hardware_concurrency();
+        args >> word >> moves >> path >> threads;
+        if (moves < 1 || moves > MAX_MATE_MOVES) {
+            out << "❌ Invalid move count! Use: mate 2 [puzzles.epd] [threads]\n";
+            return;
+        }
+        if (path.empty())
+            runMate(chess_game, moves, out, cache);
+        else
+            runMateFile(path, moves, threadCount(threads), out, cache);
+    }
+    else if (first_word == "fen") {
+        // Piece letters are case sensitive, so read from the raw input
+        std::string fen = input.substr(input.find_first_of(" \t") + 1);
+        if (input.find_first_of(" \t") == std::string::npos ||
+            !chess_game.loadFen(fen)) {
+            out << "❌ Invalid FEN!\n";
+        }
+    }
+    else if (first_word == "flip" || first_word == "rotate") {
+        out << "🔄 Flipping board perspective...\n";
+        chess_game.changeColor();
+    }
+    else if (first_word == "board" || first_word == "display" || first_word == "show") {
+        out << "📋 Current board position:\n";
+        // Board will be displayed in main loop
+    }
+    else if (first_word == "help" || first_word == "h" || first_word == "?") {
+        printHelp();
+    }
+    else if (first_word == "quit" || first_word == "exit" || first_word == "q") {
+        out << "👋 Thanks for playing Mate++!\n";
+        running = false;
+    }
+    else {
+        out << "❓ Unknown command: '" << first_word << "'\n";
+        out << "💡 Type 'help' to see available commands\n";
+    }
+}
+
+void ChessUI::printPrompt() {
+    out << "\n";
+    chess_game.readBoard(false);
+    out << "\n";
+    printStatus();
+    out << "♟️  > ";
+}
+
+void ChessUI::handleLine(std::string input) {
+    // Trim whitespace (and the carriage return of socket clients)
+    input.erase(0, input.find_first_not_of(" \t\r"));
+    input.erase(input.find_last_not_of(" \t\r") + 1);
+
+    if (!input.empty()) {
+        processCommand(input);
+    }
+}
+
+void ChessUI::reset() {
+    chess_game = game(out);
+    running = true;
+}
+
+void ChessUI::run() {
+    printWelcome();
+    printHelp();
+
+    std::string input;
+    while (running) {
+        printPrompt();
+
+        if (!std::getline(std::cin, input)) {
+            break; // EOF or error
+        }
+
+        handleLine(input);
+    }
+}